@@ -42,6 +42,19 @@ namespace dci::module::ppn::transport::net
             return cmt::readyFuture(std::numeric_limits<real64>::max());
         };
 
+        //in stats() -> Stats;
+        methods()->stats() += sol() * [this]
+        {
+            return cmt::readyFuture(_stats->snapshot());
+        };
+
+        //in setShaping(Shaping aggregate, Shaping channel) -> none;
+        methods()->setShaping() += sol() * [this](api::Shaping&& aggregate, api::Shaping&& channel)
+        {
+            _shaper->setup(aggregate, channel);
+            return cmt::readyFuture(None{});
+        };
+
         //in bind(Address) -> void;
         methods()->bind() += sol() * [this](apit::Address&& address)
         {
@@ -50,12 +63,7 @@ namespace dci::module::ppn::transport::net
                 return cmt::readyFuture<None>(exception::buildInstance<api::AlreadyBound>("unable to bind after acceptor started"));
             }
 
-            auto scheme = utils::uri::scheme(address.value);
-            using namespace std::literals;
-            if("local"sv != scheme &&
-               "tcp4"sv  != scheme &&
-               "tcp6"sv  != scheme &&
-               "tcp"sv   != scheme)
+            if(!knownScheme(utils::uri::scheme(address.value)))
             {
                 return cmt::readyFuture<None>(exception::buildInstance<api::BadAddress>(address.value));
             }
@@ -84,9 +92,12 @@ namespace dci::module::ppn::transport::net
 
                     _netStreamServer->accepted() += _sow * [this](idl::net::stream::Channel<>&& netStreamChannel)
                     {
-                        netStreamChannel->setOption(idl::net::option::NoDelay{true});
+                        netStreamChannel->setOption(idl::net::option::NoDelay{true}).then() += [transportStats=_stats, phaseStart=stats::Clock::now()](auto)
+                        {
+                            transportStats->setOption().add(stats::Clock::now() - phaseStart);
+                        };
 
-                        Channel* impl = new Channel(apit::Address{}, std::move(netStreamChannel));
+                        Channel* impl = new Channel(apit::Address{}, std::move(netStreamChannel), _stats, _shaper);
                         impl->involvedChanged() += impl * [impl](bool v)
                         {
                             if(!v)
@@ -8,6 +8,8 @@
 #pragma once
 
 #include "pch.hpp"
+#include "stats.hpp"
+#include "shaper.hpp"
 
 namespace dci::module::ppn::transport::net
 {
@@ -23,13 +25,15 @@ namespace dci::module::ppn::transport::net
         String scopeValue() const;
 
     private:
-        host::Manager *             _hostManager;
-        apit::Address               _bindAddress;
-        apit::Address               _boundAddress;
-        idl::net::stream::Server<>  _netStreamServer;
-        sbs::Owner                  _sow;
-        cmt::task::Owner            _tow;
-        bool                        _started = false;
-        bool                        _listenDeclared = false;
+        host::Manager *                    _hostManager;
+        apit::Address                      _bindAddress;
+        apit::Address                      _boundAddress;
+        idl::net::stream::Server<>         _netStreamServer;
+        std::shared_ptr<stats::Transport>  _stats = std::make_shared<stats::Transport>();
+        std::shared_ptr<shaper::Transport> _shaper = std::make_shared<shaper::Transport>();
+        sbs::Owner                         _sow;
+        cmt::task::Owner                   _tow;
+        bool                               _started = false;
+        bool                               _listenDeclared = false;
     };
 }
@@ -10,44 +10,156 @@
 
 namespace dci::module::ppn::transport::net
 {
+    namespace
+    {
+        constexpr std::size_t parsedAddressCacheLimit = 4096;
+
+        //LRU, при переполнении вытесняется один самый давний адрес
+        struct ParsedAddressCache
+        {
+            using Order = std::list<String>;
+
+            Order                                                                       _order;
+            std::unordered_map<String, std::pair<ParsedAddressPtr, Order::iterator>>    _entries;
+
+            ParsedAddressPtr find(const String& key)
+            {
+                auto iter = _entries.find(key);
+                if(_entries.end() == iter)
+                    return {};
+
+                _order.splice(_order.begin(), _order, iter->second.second);
+                return iter->second.first;
+            }
+
+            void put(const String& key, ParsedAddressPtr value)
+            {
+                if(_entries.size() >= parsedAddressCacheLimit)
+                {
+                    _entries.erase(_order.back());
+                    _order.pop_back();
+                }
+
+                _order.push_front(key);
+                _entries.emplace(key, std::make_pair(std::move(value), _order.begin()));
+            }
+        };
+    }
+
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    idl::net::Endpoint address2Endpoint(idl::net::Host<>& host, const apit::Address& target)
+    ParsedAddressPtr parseAddress(const apit::Address& target)
     {
+        thread_local ParsedAddressCache cache;
+
+        if(ParsedAddressPtr res = cache.find(target.value))
+            return res;
+
         utils::URI<> uri;
         if(!utils::uri::parse(target.value, uri))
             throw api::BadAddress(target.value);
 
-        return std::visit([&]<class Alt>(const Alt& alt)
+        ParsedAddress parsed = std::visit([&]<class Alt>(const Alt& alt) -> ParsedAddress
+                                          {
+                                              if constexpr(std::is_same_v<utils::uri::TCP<>, Alt>)
+                                                  return ParsedAddress{Scheme::tcp, utils::uri::hostPort(alt)};
+                                              else if constexpr(std::is_same_v<utils::uri::TCP4<>, Alt>)
+                                                  return ParsedAddress{Scheme::tcp4, utils::uri::hostPort(alt)};
+                                              else if constexpr(std::is_same_v<utils::uri::TCP6<>, Alt>)
+                                                  return ParsedAddress{Scheme::tcp6, utils::uri::hostPort(alt)};
+                                              else if constexpr(std::is_same_v<utils::uri::Local<>, Alt>)
+                                                  return ParsedAddress{Scheme::local, utils::uri::hostPort(alt)};
+                                              else
+                                                  throw api::BadAddress(target.value);
+                                          }, uri);
+
+        ParsedAddressPtr res = std::make_shared<const ParsedAddress>(std::move(parsed));
+        cache.put(target.value, res);
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    PendingEndpoint::PendingEndpoint(idl::net::Host<>& host, const ParsedAddress& parsed)
+    {
+        switch(parsed._scheme)
+        {
+        case Scheme::tcp:
+            _state = host->resolveIp(parsed._hostPort);
+            break;
+
+        case Scheme::tcp4:
+            _state = host->resolveIp4(parsed._hostPort);
+            break;
+
+        case Scheme::tcp6:
+            _state = host->resolveIp6(parsed._hostPort);
+            break;
+
+        case Scheme::local:
+            if(!parsed._hostPort.empty())
+            {
+                std::string authority;
+                authority.reserve(parsed._hostPort.size() + 1);
+                authority.push_back('\0');
+                authority.append(parsed._hostPort);
+                _state = idl::net::Endpoint{idl::net::LocalEndpoint{std::move(authority)}};
+            }
+            else
+                _state = idl::net::Endpoint{idl::net::LocalEndpoint{}};
+            break;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    idl::net::Endpoint PendingEndpoint::value()
+    {
+        return std::visit([&]<class Alt>(Alt& alt)
                           {
                               idl::net::Endpoint ep {};
 
-                              if constexpr(std::is_same_v<utils::uri::TCP<>, Alt>)
+                              if constexpr(std::is_same_v<idl::net::Endpoint, Alt>)
+                                  ep = alt;
+                              else if constexpr(std::is_same_v<cmt::Future<idl::net::IpEndpoint>, Alt>)
                               {
-                                  idl::net::IpEndpoint epIp = host->resolveIp(utils::uri::hostPort(alt)).value();
+                                  idl::net::IpEndpoint epIp = alt.value();
                                   if(epIp.holds<idl::net::Ip4Endpoint>())
                                       ep = epIp.get<idl::net::Ip4Endpoint>();
                                   else if(epIp.holds<idl::net::Ip6Endpoint>())
                                       ep = epIp.get<idl::net::Ip6Endpoint>();
                               }
-                              else if constexpr(std::is_same_v<utils::uri::TCP4<>, Alt>)
-                                  ep = host->resolveIp4(utils::uri::hostPort(alt)).value();
-                              else if constexpr(std::is_same_v<utils::uri::TCP6<>, Alt>)
-                                  ep = host->resolveIp6(utils::uri::hostPort(alt)).value();
-                              else if constexpr(std::is_same_v<utils::uri::Local<>, Alt>)
-                              {
-                                  std::string authority = utils::uri::hostPort(alt);
-                                  if(!authority.empty())
-                                  {
-                                      authority.insert(0, 1, '\0');
-                                      ep = idl::net::LocalEndpoint{std::move(authority)};
-                                  }
-                                  else
-                                      ep = idl::net::LocalEndpoint{};
-                              }
                               else
-                                  throw api::BadAddress(target.value);
+                                  ep = alt.value();
 
                               return ep;
-                          }, uri);
+                          }, _state);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    idl::net::Endpoint PendingEndpoint::value(poll::WaitableTimer& deadline)
+    {
+        std::visit([&]<class Alt>(Alt& alt)
+                   {
+                       if constexpr(!std::is_same_v<idl::net::Endpoint, Alt>)
+                       {
+                           if(0 == cmt::waitAny(deadline.waitable(), alt.waitable()))
+                           {
+                               alt.resolveCancel();
+                               throw api::ConnectionTimeout();
+                           }
+                       }
+                   }, _state);
+
+        return value();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    idl::net::Endpoint resolveAddress(idl::net::Host<>& host, const ParsedAddress& parsed)
+    {
+        return PendingEndpoint{host, parsed}.value();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    idl::net::Endpoint address2Endpoint(idl::net::Host<>& host, const apit::Address& target)
+    {
+        return resolveAddress(host, *parseAddress(target));
     }
 }
@@ -5,9 +5,71 @@
    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
    You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
 
+#pragma once
+
 #include "pch.hpp"
 
 namespace dci::module::ppn::transport::net
 {
+    enum class Scheme
+    {
+        local,
+        tcp4,
+        tcp6,
+        tcp,
+    };
+
+    inline constexpr std::array<std::pair<std::string_view, Scheme>, 4> schemes
+    {{
+        {"local",   Scheme::local},
+        {"tcp4",    Scheme::tcp4},
+        {"tcp6",    Scheme::tcp6},
+        {"tcp",     Scheme::tcp},
+    }};
+
+    constexpr std::optional<Scheme> knownScheme(std::string_view name)
+    {
+        for(const auto& [n, s] : schemes)
+        {
+            if(n == name)
+            {
+                return s;
+            }
+        }
+
+        return {};
+    }
+
+    struct ParsedAddress
+    {
+        Scheme      _scheme;
+        std::string _hostPort;
+    };
+
+    using ParsedAddressPtr = std::shared_ptr<const ParsedAddress>;
+
+    //разбирается один раз на каждое различное значение адреса, дальше берется из кеша потока
+    ParsedAddressPtr parseAddress(const apit::Address& target);
+
+    //запрос на резолв уходит в host при конструировании, value() ждет ответ,
+    //таких запросов может висеть много одновременно
+    class PendingEndpoint
+    {
+    public:
+        PendingEndpoint(idl::net::Host<>& host, const ParsedAddress& parsed);
+
+        idl::net::Endpoint value();
+        idl::net::Endpoint value(poll::WaitableTimer& deadline);
+
+    private:
+        std::variant<
+            idl::net::Endpoint,
+            cmt::Future<idl::net::IpEndpoint>,
+            cmt::Future<idl::net::Ip4Endpoint>,
+            cmt::Future<idl::net::Ip6Endpoint>> _state;
+    };
+
+    idl::net::Endpoint resolveAddress(idl::net::Host<>& host, const ParsedAddress& parsed);
+
     idl::net::Endpoint address2Endpoint(idl::net::Host<>& host, const apit::Address& target);
 }
@@ -11,10 +11,15 @@
 namespace dci::module::ppn::transport::net
 {
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    Channel::Channel(apit::Address&& originalRemoteAddress, idl::net::stream::Channel<>&& netStreamChannel)
+    Channel::Channel(apit::Address&& originalRemoteAddress,
+                     idl::net::stream::Channel<>&& netStreamChannel,
+                     std::shared_ptr<stats::Transport> transportStats,
+                     std::shared_ptr<shaper::Transport> transportShaper)
         : apit::Channel<>::Opposite(idl::interface::Initializer{})
         , _originalRemoteAddress(std::move(originalRemoteAddress))
         , _netStreamChannel(std::move(netStreamChannel))
+        , _stats(std::move(transportStats), _originalRemoteAddress)
+        , _shaper(std::move(transportShaper), _originalRemoteAddress, _netStreamChannel, _stats)
     {
         methods()->localAddress() += this * [this]()
         {
@@ -61,37 +66,46 @@ namespace dci::module::ppn::transport::net
 
         methods()->unlockInput() += this * [this]() -> void
         {
+            _stats.unlockInput();
             return _netStreamChannel->startReceive();
         };
 
         methods()->lockInput() += this * [this]() -> void
         {
-             return _netStreamChannel->stopReceive();
+            _stats.lockInput();
+            return _netStreamChannel->stopReceive();
         };
 
         _netStreamChannel->failed() += this * [this](auto&& e)
         {
+            _shaper.drop();
             methods()->failed(std::forward<decltype(e)>(e));
         };
 
         methods()->close() += this * [this]() -> void
         {
-            _netStreamChannel->close();
+            if(_shaper.flush())
+            {
+                _netStreamChannel->close();
+            }
         };
 
         _netStreamChannel->closed() += this * [this]()
         {
+            _shaper.drop();
             methods()->closed();
         };
 
         _netStreamChannel->received() += this * [this](auto&& data)
         {
+            _stats.input(data.size());
             methods()->input(std::forward<decltype(data)>(data));
         };
 
         methods()->output() += this * [this](auto&& data)
         {
-            _netStreamChannel->send(std::forward<decltype(data)>(data));
+            _stats.output(data.size());
+            _shaper.output(std::forward<decltype(data)>(data));
         };
     }
 
@@ -8,6 +8,8 @@
 #pragma once
 
 #include "pch.hpp"
+#include "stats.hpp"
+#include "shaper.hpp"
 
 namespace dci::module::ppn::transport::net
 {
@@ -17,11 +19,16 @@ namespace dci::module::ppn::transport::net
         , public mm::heap::Allocable<Channel>
     {
     public:
-        Channel(apit::Address&& originalRemoteAddress, idl::net::stream::Channel<>&& netStreamChannel);
+        Channel(apit::Address&& originalRemoteAddress,
+                idl::net::stream::Channel<>&& netStreamChannel,
+                std::shared_ptr<stats::Transport> transportStats,
+                std::shared_ptr<shaper::Transport> transportShaper);
         ~Channel();
 
     private:
         apit::Address               _originalRemoteAddress;
         idl::net::stream::Channel<> _netStreamChannel;
+        stats::Channel              _stats;
+        shaper::Channel             _shaper;
     };
 }
@@ -41,15 +41,30 @@ namespace dci::module::ppn::transport::net
             return cmt::readyFuture(std::numeric_limits<real64>::max());
         };
 
+        //in stats() -> Stats;
+        methods()->stats() += sol() * [this]
+        {
+            return cmt::readyFuture(_stats->snapshot());
+        };
+
+        //in setShaping(Shaping aggregate, Shaping channel) -> none;
+        methods()->setShaping() += sol() * [this](api::Shaping&& aggregate, api::Shaping&& channel)
+        {
+            _shaper->setup(aggregate, channel);
+            return cmt::readyFuture(None{});
+        };
+
+        //in setChannelWeight(Address, uint32) -> none;
+        methods()->setChannelWeight() += sol() * [this](apit::Address&& address, uint32 weight)
+        {
+            _shaper->setWeight(address, weight);
+            return cmt::readyFuture(None{});
+        };
+
         //in bind(Address) -> void;
         methods()->bind() += sol() * [this](apit::Address&& address)
         {
-            auto scheme = utils::uri::scheme(address.value);
-            using namespace std::literals;
-            if("local"sv != scheme &&
-               "tcp4"sv  != scheme &&
-               "tcp6"sv  != scheme &&
-               "tcp"sv   != scheme)
+            if(!knownScheme(utils::uri::scheme(address.value)))
             {
                 return cmt::readyFuture<None>(exception::buildInstance<api::BadAddress>(address.value));
             }
@@ -91,36 +106,11 @@ namespace dci::module::ppn::transport::net
 
                 try
                 {
-                    cmt::Future<idl::net::stream::Channel<>> netStreamChannelFuture = _netStreamClient.value()->connect(address2Endpoint(_netHost.value(), address));
-                    poll::WaitableTimer deadline{std::chrono::seconds{2}};
-                    deadline.start();
+                    idl::net::stream::Channel<> netStreamChannel = connectNetStream(address);
 
-                    if(0 == cmt::waitAny(deadline.waitable(), netStreamChannelFuture.waitable()))
-                    {
-                        netStreamChannelFuture.resolveCancel();
-                        if(!out.resolved())
-                        {
-                            out.resolveException(exception::buildInstance<api::ConnectionTimeout>());
-                        }
-                    }
-                    else
+                    if(!out.resolved())
                     {
-                        idl::net::stream::Channel<> netStreamChannel = netStreamChannelFuture.value();
-                        netStreamChannel->setOption(idl::net::option::NoDelay{true});
-
-                        if(!out.resolved())
-                        {
-                            Channel* impl = new Channel(apit::Address{address}, std::move(netStreamChannel));
-                            impl->involvedChanged() += impl * [impl](bool v)
-                            {
-                                if(!v)
-                                {
-                                    delete impl;
-                                }
-                            };
-
-                            out.resolveValue(impl->opposite());
-                        }
+                        out.resolveValue(makeChannel(address, std::move(netStreamChannel)));
                     }
                 }
                 catch(const cmt::task::Stop&)
@@ -141,6 +131,42 @@ namespace dci::module::ppn::transport::net
             };
         };
 
+        //in connectBatch(list<Address>) -> uint64;
+        methods()->connectBatch() += sol() * [this](auto&& addresses)
+        {
+            std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+            batch->_id = ++_lastBatchId;
+
+            std::set<String> seen;
+            for(const apit::Address& address : addresses)
+            {
+                if(seen.insert(address.value).second)
+                {
+                    batch->_addresses.emplace_back(address);
+                }
+            }
+            batch->_remain = batch->_addresses.size();
+            batch->_handled.resize(batch->_addresses.size(), false);
+
+            cmt::spawn() += _tol * [this, batch]
+            {
+                try
+                {
+                    runBatch(batch);
+                }
+                catch(const cmt::task::Stop&)
+                {
+                    //empty is ok
+                }
+                catch(...)
+                {
+                    batchFail(batch, std::current_exception());
+                }
+            };
+
+            return cmt::readyFuture(uint64{batch->_id});
+        };
+
         _netHost = _hostManager->createService<idl::net::Host<>>();
 
         _netStreamClient = _netHost.apply(sol(), [](cmt::Future<idl::net::Host<>> in, cmt::Promise<idl::net::stream::Client<>> out)
@@ -158,4 +184,206 @@ namespace dci::module::ppn::transport::net
         sol().flush();
         _tol.stop();
     }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    idl::net::stream::Channel<> Connector::connectNetStream(const apit::Address& address)
+    {
+        idl::net::Host<>& netHost = _netHost.value();
+
+        stats::Clock::time_point phaseStart = stats::Clock::now();
+        ParsedAddressPtr parsed = parseAddress(address);
+        stats::Clock::time_point phaseStop = stats::Clock::now();
+        _stats->uriParse().add(phaseStop - phaseStart);
+
+        phaseStart = phaseStop;
+        idl::net::Endpoint endpoint = resolveAddress(netHost, *parsed);
+        _stats->resolve().add(stats::Clock::now() - phaseStart);
+
+        poll::WaitableTimer deadline{_connectTimeout};
+        deadline.start();
+
+        return connectNetStream(std::move(endpoint), deadline);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    idl::net::stream::Channel<> Connector::connectNetStream(idl::net::Endpoint&& endpoint, poll::WaitableTimer& deadline)
+    {
+        idl::net::stream::Client<>& netStreamClient = _netStreamClient.value();
+
+        stats::Clock::time_point phaseStart = stats::Clock::now();
+        cmt::Future<idl::net::stream::Channel<>> netStreamChannelFuture = netStreamClient->connect(std::move(endpoint));
+
+        if(0 == cmt::waitAny(deadline.waitable(), netStreamChannelFuture.waitable()))
+        {
+            netStreamChannelFuture.resolveCancel();
+            throw api::ConnectionTimeout();
+        }
+
+        idl::net::stream::Channel<> netStreamChannel = netStreamChannelFuture.value();
+        stats::Clock::time_point phaseStop = stats::Clock::now();
+        _stats->tcpConnect().add(phaseStop - phaseStart);
+
+        netStreamChannel->setOption(idl::net::option::NoDelay{true}).then() += [transportStats=_stats, phaseStart=phaseStop](auto)
+        {
+            transportStats->setOption().add(stats::Clock::now() - phaseStart);
+        };
+
+        return netStreamChannel;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    apit::Channel<> Connector::makeChannel(const apit::Address& address, idl::net::stream::Channel<>&& netStreamChannel)
+    {
+        Channel* impl = new Channel(apit::Address{address}, std::move(netStreamChannel), _stats, _shaper);
+        impl->involvedChanged() += impl * [impl](bool v)
+        {
+            if(!v)
+            {
+                delete impl;
+            }
+        };
+
+        return impl->opposite();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Connector::runBatch(const std::shared_ptr<Batch>& batch)
+    {
+        if(!batch->_remain)
+        {
+            methods()->batchCompleted(batch->_id);
+            return;
+        }
+
+        idl::net::Host<>& netHost = _netHost.value();
+
+        //все запросы на резолв уходят разом, до первого SYN
+        std::vector<std::optional<PendingEndpoint>> endpoints;
+        endpoints.reserve(batch->_addresses.size());
+        for(std::size_t i{}; i<batch->_addresses.size(); ++i)
+        {
+            const apit::Address& address = batch->_addresses[i];
+            try
+            {
+                stats::Clock::time_point phaseStart = stats::Clock::now();
+                ParsedAddressPtr parsed = parseAddress(address);
+                _stats->uriParse().add(stats::Clock::now() - phaseStart);
+
+                endpoints.emplace_back(std::in_place, netHost, *parsed);
+            }
+            catch(const cmt::task::Stop&)
+            {
+                throw;
+            }
+            catch(...)
+            {
+                endpoints.emplace_back();
+                batch->_handled[i] = true;
+                methods()->batchFailed(batch->_id, address, std::current_exception());
+                batchDone(batch);
+            }
+        }
+
+        //SYN-ы выпускаются волнами не чаще _batchLaunchesPerTick за _batchTick и не более _batchInFlightLimit одновременно,
+        //у всей волны один общий таймер на ожидание резолва и коннект
+        std::shared_ptr<poll::WaitableTimer> deadline;
+        std::size_t launchedInWave{};
+
+        for(std::size_t i{}; i<endpoints.size(); ++i)
+        {
+            if(!endpoints[i])
+            {
+                continue;
+            }
+
+            bool newWave = !deadline;
+
+            if(launchedInWave >= _batchLaunchesPerTick)
+            {
+                poll::WaitableTimer tick{_batchTick};
+                tick.start();
+                cmt::waitAny(tick.waitable());
+                newWave = true;
+            }
+
+            while(batch->_inFlight >= _batchInFlightLimit)
+            {
+                batch->_slotFreed.reset();
+                cmt::waitAny(batch->_slotFreed.waitable());
+                newWave = true;
+            }
+
+            if(newWave)
+            {
+                launchedInWave = 0;
+                deadline = std::make_shared<poll::WaitableTimer>(_connectTimeout);
+                deadline->start();
+            }
+
+            ++batch->_inFlight;
+            ++launchedInWave;
+
+            cmt::spawn() += _tol * [this, batch, deadline, address=batch->_addresses[i], endpoint=std::move(*endpoints[i])]() mutable
+            {
+                utils::AtScopeExit inFlight{[&]
+                {
+                    --batch->_inFlight;
+                    batch->_slotFreed.raise();
+                }};
+
+                std::optional<idl::net::stream::Channel<>> netStreamChannel;
+
+                try
+                {
+                    stats::Clock::time_point phaseStart = stats::Clock::now();
+                    idl::net::Endpoint resolved = endpoint.value(*deadline);
+                    _stats->resolve().add(stats::Clock::now() - phaseStart);
+
+                    netStreamChannel.emplace(connectNetStream(std::move(resolved), *deadline));
+                }
+                catch(const cmt::task::Stop&)
+                {
+                    //empty is ok
+                    return;
+                }
+                catch(...)
+                {
+                    methods()->batchFailed(batch->_id, address, std::current_exception());
+                }
+
+                if(netStreamChannel)
+                {
+                    methods()->batchConnected(batch->_id, address, makeChannel(address, std::move(*netStreamChannel)));
+                }
+
+                batchDone(batch);
+            };
+
+            batch->_handled[i] = true;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Connector::batchDone(const std::shared_ptr<Batch>& batch)
+    {
+        if(!--batch->_remain)
+        {
+            methods()->batchCompleted(batch->_id);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Connector::batchFail(const std::shared_ptr<Batch>& batch, const ExceptionPtr& e)
+    {
+        //каждый адрес, еще не отданный воркеру, получает ошибку, иначе batchCompleted не наступит
+        for(std::size_t i{}; i<batch->_addresses.size(); ++i)
+        {
+            if(!batch->_handled[i])
+            {
+                batch->_handled[i] = true;
+                methods()->batchFailed(batch->_id, batch->_addresses[i], ExceptionPtr{e});
+                batchDone(batch);
+            }
+        }
+    }
 }
@@ -8,6 +8,8 @@
 #pragma once
 
 #include "pch.hpp"
+#include "stats.hpp"
+#include "shaper.hpp"
 
 namespace dci::module::ppn::transport::net
 {
@@ -20,11 +22,37 @@ namespace dci::module::ppn::transport::net
         ~Connector();
 
     private:
+        struct Batch
+        {
+            uint64                      _id{};
+            std::vector<apit::Address>  _addresses;
+            std::size_t                 _inFlight{};
+            std::vector<bool>           _handled;
+            std::size_t                 _remain{};
+            cmt::Event                  _slotFreed;
+        };
+
+        idl::net::stream::Channel<> connectNetStream(const apit::Address& address);
+        idl::net::stream::Channel<> connectNetStream(idl::net::Endpoint&& endpoint, poll::WaitableTimer& deadline);
+        apit::Channel<> makeChannel(const apit::Address& address, idl::net::stream::Channel<>&& netStreamChannel);
+        void runBatch(const std::shared_ptr<Batch>& batch);
+        void batchDone(const std::shared_ptr<Batch>& batch);
+        void batchFail(const std::shared_ptr<Batch>& batch, const ExceptionPtr& e);
+
+    private:
+        static constexpr std::chrono::seconds       _connectTimeout{2};
+        static constexpr std::size_t                _batchInFlightLimit = 128;
+        static constexpr std::size_t                _batchLaunchesPerTick = 32;
+        static constexpr std::chrono::milliseconds  _batchTick{1};
+
         host::Manager *                             _hostManager;
         cmt::Future<idl::net::Host<>>               _netHost;
         cmt::Future<idl::net::stream::Client<>>     _netStreamClient;
 
         apit::Address                               _address;
+        std::shared_ptr<stats::Transport>           _stats = std::make_shared<stats::Transport>();
+        std::shared_ptr<shaper::Transport>          _shaper = std::make_shared<shaper::Transport>();
+        uint64                                      _lastBatchId{};
 
         cmt::task::Owner                            _tol;
     };
@@ -7,6 +7,21 @@
 
 #pragma once
 
+#include <atomic>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
 #include <dci/host.hpp>
 #include <dci/utils/atScopeExit.hpp>
 #include <dci/utils/uri.hpp>
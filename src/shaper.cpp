@@ -0,0 +1,450 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "pch.hpp"
+#include "shaper.hpp"
+
+namespace dci::module::ppn::transport::net::shaper
+{
+    namespace
+    {
+        // bytes granted to a channel with weight 1 per round of the fair queue
+        constexpr std::size_t quantum = 16*1024;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void TokenBucket::setup(const api::Shaping& cfg)
+    {
+        _rate = static_cast<real64>(cfg.rate);
+        _burst = static_cast<real64>(std::max(cfg.burst, uint64{1}));
+        _tokens = _burst;
+        _stamp = Clock::now();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool TokenBucket::ready(Clock::time_point now)
+    {
+        if(unlimited())
+        {
+            return true;
+        }
+
+        if(_tokens < _burst)
+        {
+            _tokens = std::min(_burst, _tokens + _rate * std::chrono::duration<real64>(now - _stamp).count());
+        }
+        _stamp = now;
+
+        return _tokens > 0;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void TokenBucket::consume(std::size_t size)
+    {
+        if(!unlimited())
+        {
+            _tokens -= static_cast<real64>(size);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Clock::duration TokenBucket::waitFor() const
+    {
+        if(unlimited() || _tokens > 0)
+        {
+            return {};
+        }
+
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<real64>((1 - _tokens) / _rate));
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Transport::~Transport()
+    {
+        _tow.stop();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::setup(const api::Shaping& aggregate, const api::Shaping& channel)
+    {
+        _bucket.setup(aggregate);
+        _channelCfg = channel;
+
+        for(Channel* c : _channels)
+        {
+            c->_bucket.setup(_channelCfg);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::setWeight(const apit::Address& address, uint32 weight)
+    {
+        weight = std::max(weight, uint32{1});
+        _weights[address.value] = weight;
+
+        for(Channel* c : _channels)
+        {
+            if(c->_originalRemoteAddress.value == address.value)
+            {
+                c->_weight = weight;
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::attach(Channel* channel)
+    {
+        _channels.insert(channel);
+
+        channel->_bucket.setup(_channelCfg);
+
+        auto iter = _weights.find(channel->_originalRemoteAddress.value);
+        if(_weights.end() != iter)
+        {
+            channel->_weight = iter->second;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::detach(Channel* channel)
+    {
+        _channels.erase(channel);
+
+        if(channel->_active)
+        {
+            std::erase(_active, channel);
+            channel->_active = false;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::activate(Channel* channel)
+    {
+        if(channel->_active)
+        {
+            return;
+        }
+
+        channel->_active = true;
+        _active.push_back(channel);
+
+        if(_draining)
+        {
+            //drain может спать по таймеру чужого канала, новый канал должен быть обслужен сразу
+            _wakeup.raise();
+            return;
+        }
+
+        spawnDrain();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::spawnDrain()
+    {
+        _draining = true;
+        cmt::spawn() += _tow * [this]
+        {
+            drain();
+        };
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool Transport::passThrough(Clock::time_point now)
+    {
+        //каналы, ограниченные только собственным bucket-ом, не повод задерживать остальных
+        return !_starved && _bucket.ready(now);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::drain()
+    {
+        std::weak_ptr<bool> transportAlive = _alive;
+        std::vector<Bytes> sends;
+
+        //обслуживаемый в данный момент канал, на случай исключения
+        Channel* current = nullptr;
+        std::weak_ptr<bool> currentAlive;
+
+        try
+        {
+            while(!_active.empty())
+            {
+                Clock::time_point now = Clock::now();
+                Clock::duration wait = Clock::duration::max();
+                bool progress = false;
+                bool starved = false;
+
+                //один раунд deficit round robin по активным каналам
+                for(std::size_t amount = _active.size(); amount && !_active.empty(); --amount)
+                {
+                    if(!_bucket.ready(now))
+                    {
+                        wait = std::min(wait, _bucket.waitFor());
+                        starved = true;
+                        break;
+                    }
+
+                    Channel* channel = _active.front();
+                    _active.pop_front();
+
+                    current = channel;
+                    currentAlive = channel->_alive;
+
+                    Channel::Served served = channel->serve(now, _bucket, wait, sends);
+                    switch(served)
+                    {
+                    case Channel::Served::drained:
+                    case Channel::Served::pending:
+                        progress = true;
+                        break;
+                    case Channel::Served::starved:
+                        progress = true;
+                        starved = true;
+                        break;
+                    case Channel::Served::throttled:
+                        break;
+                    }
+
+                    if(Channel::Served::drained == served)
+                    {
+                        channel->_active = false;
+                    }
+                    else
+                    {
+                        _active.push_back(channel);
+                    }
+
+                    //вся бухгалтерия сделана до send, он может синхронно привести к удалению канала и даже транспорта
+                    for(Bytes& data : sends)
+                    {
+                        if(currentAlive.expired())
+                        {
+                            break;
+                        }
+
+                        channel->send(std::move(data));
+
+                        if(transportAlive.expired())
+                        {
+                            return;
+                        }
+                    }
+                    sends.clear();
+                    current = nullptr;
+                }
+
+                _starved = starved;
+
+                if(_active.empty())
+                {
+                    break;
+                }
+
+                if(progress)
+                {
+                    cmt::yield();
+                }
+                else
+                {
+                    std::chrono::milliseconds ms{1};
+                    if(Clock::duration::max() != wait)
+                    {
+                        ms = std::max(ms, std::chrono::ceil<std::chrono::milliseconds>(wait));
+                    }
+
+                    _wakeup.reset();
+                    poll::WaitableTimer timer{ms};
+                    timer.start();
+                    cmt::waitAny(timer.waitable(), _wakeup.waitable());
+                }
+            }
+        }
+        catch(const cmt::task::Stop&)
+        {
+            //empty is ok
+            return;
+        }
+        catch(...)
+        {
+            if(transportAlive.expired())
+            {
+                return;
+            }
+
+            //виноватый канал теряет свою очередь, остальные продолжают обслуживаться
+            if(current && !currentAlive.expired())
+            {
+                current->drop();
+            }
+
+            _starved = false;
+            _draining = false;
+
+            if(!_active.empty())
+            {
+                spawnDrain();
+            }
+            return;
+        }
+
+        _starved = false;
+        _draining = false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Channel::Channel(std::shared_ptr<Transport> transport, const apit::Address& originalRemoteAddress, idl::net::stream::Channel<>& sink, stats::Channel& stats)
+        : _transport(std::move(transport))
+        , _originalRemoteAddress(originalRemoteAddress)
+        , _sink(sink)
+        , _stats(stats)
+    {
+        _transport->attach(this);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Channel::~Channel()
+    {
+        _transport->detach(this);
+
+        //канал отпускают без close - накопленное уходит в поток сразу, а не теряется
+        try
+        {
+            while(!_queue.empty())
+            {
+                Bytes data = std::move(_queue.front());
+                _queue.pop_front();
+                send(std::move(data));
+            }
+        }
+        catch(...)
+        {
+            _queue.clear();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Channel::output(Bytes&& data)
+    {
+        if(_queue.empty())
+        {
+            if(_bucket.unlimited() && _transport->_bucket.unlimited())
+            {
+                send(std::move(data));
+                return;
+            }
+
+            Clock::time_point now = Clock::now();
+            if(_bucket.ready(now) && _transport->passThrough(now))
+            {
+                std::size_t size = data.size();
+                _bucket.consume(size);
+                _transport->_bucket.consume(size);
+                send(std::move(data));
+                return;
+            }
+        }
+
+        //данные не копируются, только откладываются до появления токенов
+        _queue.push_back(std::move(data));
+        _transport->activate(this);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool Channel::flush()
+    {
+        deactivate();
+
+        std::weak_ptr<bool> alive = _alive;
+
+        while(!_queue.empty())
+        {
+            Bytes data = std::move(_queue.front());
+            _queue.pop_front();
+
+            std::size_t size = data.size();
+            _bucket.consume(size);
+            _transport->_bucket.consume(size);
+
+            send(std::move(data));
+
+            if(alive.expired())
+            {
+                return false;
+            }
+        }
+
+        _deficit = 0;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Channel::drop()
+    {
+        deactivate();
+        _queue.clear();
+        _deficit = 0;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Channel::deactivate()
+    {
+        if(_active)
+        {
+            std::erase(_transport->_active, this);
+            _active = false;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Channel::Served Channel::serve(Clock::time_point now, TokenBucket& aggregate, Clock::duration& wait, std::vector<Bytes>& sends)
+    {
+        if(_queue.empty())
+        {
+            _deficit = 0;
+            return Served::drained;
+        }
+
+        if(!_bucket.ready(now))
+        {
+            wait = std::min(wait, _bucket.waitFor());
+            return Served::throttled;
+        }
+
+        _deficit += quantum * _weight;
+
+        while(!_queue.empty())
+        {
+            std::size_t size = _queue.front().size();
+            if(size > _deficit)
+            {
+                return Served::pending;
+            }
+
+            if(!_bucket.ready(now))
+            {
+                wait = std::min(wait, _bucket.waitFor());
+                return Served::throttled;
+            }
+
+            if(!aggregate.ready(now))
+            {
+                wait = std::min(wait, aggregate.waitFor());
+                return Served::starved;
+            }
+
+            _deficit -= size;
+            _bucket.consume(size);
+            aggregate.consume(size);
+
+            sends.push_back(std::move(_queue.front()));
+            _queue.pop_front();
+        }
+
+        _deficit = 0;
+        return Served::drained;
+    }
+}
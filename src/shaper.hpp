@@ -0,0 +1,128 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "pch.hpp"
+#include "stats.hpp"
+
+namespace dci::module::ppn::transport::net::shaper
+{
+    using Clock = std::chrono::steady_clock;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    class TokenBucket
+    {
+    public:
+        void setup(const api::Shaping& cfg);
+
+        bool unlimited() const;
+        bool ready(Clock::time_point now);
+        void consume(std::size_t size);
+        Clock::duration waitFor() const;
+
+    private:
+        real64              _rate{};
+        real64              _burst{};
+        real64              _tokens{};
+        Clock::time_point   _stamp{};
+    };
+
+    class Channel;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    class Transport
+    {
+    public:
+        ~Transport();
+
+        void setup(const api::Shaping& aggregate, const api::Shaping& channel);
+        void setWeight(const apit::Address& address, uint32 weight);
+
+    private:
+        friend class Channel;
+        void attach(Channel* channel);
+        void detach(Channel* channel);
+        void activate(Channel* channel);
+        bool passThrough(Clock::time_point now);
+        void spawnDrain();
+        void drain();
+
+    private:
+        TokenBucket                 _bucket;
+        api::Shaping                _channelCfg{};
+        std::map<String, uint32>    _weights;
+
+        std::set<Channel*>          _channels;
+        std::deque<Channel*>        _active;
+
+        //кто-то из активных ждет токенов именно общего bucket-а
+        bool                        _starved = false;
+
+        std::shared_ptr<bool>       _alive = std::make_shared<bool>(true);
+        cmt::Event                  _wakeup;
+        cmt::task::Owner            _tow;
+        bool                        _draining = false;
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    class Channel
+    {
+    public:
+        Channel(std::shared_ptr<Transport> transport, const apit::Address& originalRemoteAddress, idl::net::stream::Channel<>& sink, stats::Channel& stats);
+        ~Channel();
+
+        void output(Bytes&& data);
+
+        //отправить все накопленное сразу, без учета bucket-ов; false если канал при этом умер
+        bool flush();
+
+        //выбросить накопленное, поток уже непригоден для записи
+        void drop();
+
+    private:
+        friend class Transport;
+
+        enum class Served
+        {
+            drained,    //очередь пуста
+            pending,    //deficit на этот раунд исчерпан
+            starved,    //ждет токенов общего bucket-а
+            throttled,  //ждет токенов собственного bucket-а
+        };
+
+        Served serve(Clock::time_point now, TokenBucket& aggregate, Clock::duration& wait, std::vector<Bytes>& sends);
+        void send(Bytes&& data);
+        void deactivate();
+
+    private:
+        std::shared_ptr<Transport>      _transport;
+        const apit::Address&            _originalRemoteAddress;
+        idl::net::stream::Channel<>&    _sink;
+        stats::Channel&                 _stats;
+
+        TokenBucket                     _bucket;
+        uint32                          _weight = 1;
+        std::size_t                     _deficit = 0;
+        std::deque<Bytes>               _queue;
+        bool                            _active = false;
+        std::shared_ptr<bool>           _alive = std::make_shared<bool>(true);
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline bool TokenBucket::unlimited() const
+    {
+        return _rate <= 0;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Channel::send(Bytes&& data)
+    {
+        _stats.send();
+        _sink->send(std::move(data));
+    }
+}
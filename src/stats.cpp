@@ -0,0 +1,130 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "pch.hpp"
+#include "stats.hpp"
+
+namespace dci::module::ppn::transport::net::stats
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Histogram::add(uint64 v)
+    {
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(v, std::memory_order_relaxed);
+        _buckets[bucketIndex(v)].fetch_add(1, std::memory_order_relaxed);
+
+        uint64 cur = _min.load(std::memory_order_relaxed);
+        while(v < cur && !_min.compare_exchange_weak(cur, v, std::memory_order_relaxed));
+
+        cur = _max.load(std::memory_order_relaxed);
+        while(v > cur && !_max.compare_exchange_weak(cur, v, std::memory_order_relaxed));
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    api::Histogram Histogram::snapshot() const
+    {
+        api::Histogram res;
+
+        res.count = _count.load(std::memory_order_relaxed);
+        res.sum = _sum.load(std::memory_order_relaxed);
+        res.min = res.count ? _min.load(std::memory_order_relaxed) : 0;
+        res.max = _max.load(std::memory_order_relaxed);
+
+        std::size_t used = _bucketsAmount;
+        while(used && !_buckets[used-1].load(std::memory_order_relaxed))
+        {
+            --used;
+        }
+
+        for(std::size_t i{}; i<used; ++i)
+        {
+            res.buckets.push_back(_buckets[i].load(std::memory_order_relaxed));
+        }
+
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    api::Stats Transport::snapshot() const
+    {
+        api::Stats res;
+
+        _traffic.snapshot(res);
+
+        res.uriParse    = _uriParse.snapshot();
+        res.resolve     = _resolve.snapshot();
+        res.tcpConnect  = _tcpConnect.snapshot();
+        res.setOption   = _setOption.snapshot();
+
+        for(const Channel* channel : _channels)
+        {
+            res.channels.push_back(channel->snapshot());
+        }
+
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::attach(const Channel* channel)
+    {
+        _channels.insert(channel);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Transport::detach(const Channel* channel)
+    {
+        _channels.erase(channel);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Channel::Channel(std::shared_ptr<Transport> transport, const apit::Address& originalRemoteAddress)
+        : _transport(std::move(transport))
+        , _originalRemoteAddress(originalRemoteAddress)
+    {
+        _transport->attach(this);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Channel::~Channel()
+    {
+        unlockInput();
+        _transport->detach(this);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Channel::lockInput()
+    {
+        if(Clock::time_point{} == _inputLockedAt)
+        {
+            _inputLockedAt = Clock::now();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Channel::unlockInput()
+    {
+        if(Clock::time_point{} != _inputLockedAt)
+        {
+            Clock::duration d = Clock::now() - _inputLockedAt;
+            _inputLockedAt = {};
+
+            _traffic.inputLocked(d);
+            _transport->traffic().inputLocked(d);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    api::ChannelStats Channel::snapshot() const
+    {
+        api::ChannelStats res;
+
+        res.originalRemoteAddress = _originalRemoteAddress;
+        _traffic.snapshot(res);
+
+        return res;
+    }
+}
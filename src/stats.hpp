@@ -0,0 +1,229 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "pch.hpp"
+
+namespace dci::module::ppn::transport::net::stats
+{
+    using Clock = std::chrono::steady_clock;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    class Histogram
+    {
+    public:
+        static constexpr std::size_t _subBits = 2;
+        static constexpr std::size_t _subAmount = std::size_t{1} << _subBits;
+        static constexpr std::size_t _bucketsAmount = (64 - _subBits + 1) * _subAmount;
+
+    public:
+        void add(uint64 v);
+        void add(Clock::duration d);
+
+        api::Histogram snapshot() const;
+
+    private:
+        static std::size_t bucketIndex(uint64 v);
+
+    private:
+        std::atomic<uint64>                                 _count{};
+        std::atomic<uint64>                                 _sum{};
+        std::atomic<uint64>                                 _min{std::numeric_limits<uint64>::max()};
+        std::atomic<uint64>                                 _max{};
+        std::array<std::atomic<uint64>, _bucketsAmount>     _buckets{};
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    class Traffic
+    {
+    public:
+        void input(std::size_t size);
+        void output(std::size_t size);
+        void send();
+        void inputLocked(Clock::duration d);
+
+        template <class Dst>
+        void snapshot(Dst& dst) const;
+
+    private:
+        std::atomic<uint64>         _bytesIn{};
+        std::atomic<uint64>         _bytesOut{};
+        std::atomic<uint64>         _chunksIn{};
+        std::atomic<uint64>         _chunksOut{};
+        std::atomic<uint64>         _sendCalls{};
+
+        //~2KB, заводится только если input реально блокировался
+        std::unique_ptr<Histogram>  _inputLocked;
+    };
+
+    class Channel;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    class Transport
+    {
+    public:
+        Traffic& traffic();
+
+        Histogram& uriParse();
+        Histogram& resolve();
+        Histogram& tcpConnect();
+        Histogram& setOption();
+
+        api::Stats snapshot() const;
+
+    private:
+        friend class Channel;
+        void attach(const Channel* channel);
+        void detach(const Channel* channel);
+
+    private:
+        Traffic                     _traffic;
+
+        Histogram                   _uriParse;
+        Histogram                   _resolve;
+        Histogram                   _tcpConnect;
+        Histogram                   _setOption;
+
+        std::set<const Channel*>    _channels;
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    class Channel
+    {
+    public:
+        Channel(std::shared_ptr<Transport> transport, const apit::Address& originalRemoteAddress);
+        ~Channel();
+
+        void input(std::size_t size);
+        void output(std::size_t size);
+        void send();
+        void lockInput();
+        void unlockInput();
+
+        api::ChannelStats snapshot() const;
+
+    private:
+        std::shared_ptr<Transport>  _transport;
+        const apit::Address&        _originalRemoteAddress;
+        Traffic                     _traffic;
+        Clock::time_point           _inputLockedAt{};
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Histogram::add(Clock::duration d)
+    {
+        add(static_cast<uint64>(std::max(std::chrono::nanoseconds{}, std::chrono::duration_cast<std::chrono::nanoseconds>(d)).count()));
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline std::size_t Histogram::bucketIndex(uint64 v)
+    {
+        if(v < _subAmount)
+        {
+            return static_cast<std::size_t>(v);
+        }
+
+        std::size_t exp = static_cast<std::size_t>(std::bit_width(v)) - 1;
+        std::size_t sub = static_cast<std::size_t>(v >> (exp - _subBits)) & (_subAmount - 1);
+        return (exp - _subBits + 1) * _subAmount + sub;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Traffic::input(std::size_t size)
+    {
+        _bytesIn.fetch_add(size, std::memory_order_relaxed);
+        _chunksIn.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Traffic::output(std::size_t size)
+    {
+        _bytesOut.fetch_add(size, std::memory_order_relaxed);
+        _chunksOut.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Traffic::send()
+    {
+        _sendCalls.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Traffic::inputLocked(Clock::duration d)
+    {
+        if(!_inputLocked)
+        {
+            _inputLocked = std::make_unique<Histogram>();
+        }
+
+        _inputLocked->add(d);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <class Dst>
+    void Traffic::snapshot(Dst& dst) const
+    {
+        dst.bytesIn     = _bytesIn.load(std::memory_order_relaxed);
+        dst.bytesOut    = _bytesOut.load(std::memory_order_relaxed);
+        dst.chunksIn    = _chunksIn.load(std::memory_order_relaxed);
+        dst.chunksOut   = _chunksOut.load(std::memory_order_relaxed);
+        dst.sendCalls   = _sendCalls.load(std::memory_order_relaxed);
+        dst.inputLocked = _inputLocked ? _inputLocked->snapshot() : api::Histogram{};
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline Traffic& Transport::traffic()
+    {
+        return _traffic;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline Histogram& Transport::uriParse()
+    {
+        return _uriParse;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline Histogram& Transport::resolve()
+    {
+        return _resolve;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline Histogram& Transport::tcpConnect()
+    {
+        return _tcpConnect;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline Histogram& Transport::setOption()
+    {
+        return _setOption;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Channel::input(std::size_t size)
+    {
+        _traffic.input(size);
+        _transport->traffic().input(size);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Channel::output(std::size_t size)
+    {
+        _traffic.output(size);
+        _transport->traffic().output(size);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void Channel::send()
+    {
+        _traffic.send();
+        _transport->traffic().send();
+    }
+}
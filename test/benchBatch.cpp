@@ -0,0 +1,134 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "loopback.hpp"
+
+using namespace loopback;
+
+namespace
+{
+    constexpr std::size_t peers = 1000;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // distinct destinations, all on loopback: 127.0.x.y, the acceptor listens on 0.0.0.0
+    List<apit::Address> peerAddresses(const apit::Address& bound)
+    {
+        std::string port = bound.value.substr(bound.value.rfind(':') + 1);
+
+        List<apit::Address> res;
+        for(std::size_t i{}; i<peers; ++i)
+        {
+            res.push_back(apit::Address{"tcp4://127.0." + std::to_string(i / 250) + "." + std::to_string(i % 250 + 1) + ":" + port});
+        }
+        return res;
+    }
+
+    struct Fanout
+    {
+        real64      _ms;
+        std::size_t _connected;
+    };
+}
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(module_ppn_transport_net, benchBatchFanout)
+{
+    host::Manager* manager = host::testManager();
+    sbs::Owner owner;
+
+    api::Acceptor<> acceptor = manager->createService<api::Acceptor<>>().value();
+    std::vector<apit::Channel<>> accepted;
+    List<apit::Address> addresses = peerAddresses(listen(acceptor, apit::Address{"tcp4://0.0.0.0:0"}, owner, accepted));
+
+    //по одному connect на пира, все разом
+    Fanout single{};
+    {
+        api::Connector<> connector = manager->createService<api::Connector<>>().value();
+        std::vector<apit::Channel<>> channels;
+
+        Clock::time_point start = Clock::now();
+
+        std::vector<cmt::Future<apit::Channel<>>> futures;
+        for(const apit::Address& address : addresses)
+        {
+            futures.push_back(connector->connect(address));
+        }
+
+        for(cmt::Future<apit::Channel<>>& f : futures)
+        {
+            try
+            {
+                channels.push_back(f.value());
+            }
+            catch(...)
+            {
+            }
+        }
+
+        single = Fanout{std::chrono::duration<real64, std::milli>(Clock::now() - start).count(), channels.size()};
+
+        for(apit::Channel<>& c : channels)
+        {
+            c->close();
+        }
+    }
+    EXPECT_TRUE(waitUntil([&]{return accepted.size() == single._connected;}));
+    accepted.clear();
+
+    //один connectBatch на всех, плюс по дубликату каждого адреса
+    Fanout batch{};
+    {
+        api::Connector<> connector = manager->createService<api::Connector<>>().value();
+        std::vector<apit::Channel<>> channels;
+        std::size_t failed{};
+        bool completed = false;
+
+        connector->batchConnected() += owner * [&](auto&&, auto&&, auto&& channel)
+        {
+            channels.emplace_back(std::forward<decltype(channel)>(channel));
+        };
+
+        connector->batchFailed() += owner * [&](auto&&, auto&&, auto&&)
+        {
+            ++failed;
+        };
+
+        connector->batchCompleted() += owner * [&](auto&&)
+        {
+            completed = true;
+        };
+
+        List<apit::Address> withDuplicates = addresses;
+        for(const apit::Address& address : addresses)
+        {
+            withDuplicates.push_back(address);
+        }
+
+        Clock::time_point start = Clock::now();
+        connector->connectBatch(std::move(withDuplicates)).value();
+        EXPECT_TRUE(waitUntil([&]{return completed;}, std::chrono::seconds{30}));
+
+        batch = Fanout{std::chrono::duration<real64, std::milli>(Clock::now() - start).count(), channels.size()};
+        EXPECT_EQ(channels.size() + failed, peers);
+
+        owner.flush();
+        for(apit::Channel<>& c : channels)
+        {
+            c->close();
+        }
+    }
+
+    std::cout << "fan-out to " << peers << " peers, time to last connection:"
+              << " single connects " << single._ms << "ms (" << single._connected << " connected),"
+              << " connectBatch " << batch._ms << "ms (" << batch._connected << " connected)" << std::endl;
+
+    EXPECT_EQ(single._connected, peers);
+    EXPECT_EQ(batch._connected, peers);
+
+    owner.flush();
+    acceptor->stop();
+}
@@ -0,0 +1,98 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/test.hpp>
+#include "pch.hpp"
+#include "address2Endpoint.hpp"
+
+using namespace dci;
+using namespace dci::module::ppn::transport::net;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // то, что делалось на каждый bind/connect до кеша: цепочка сравнений схемы, parse, visit с копией hostPort
+    std::string uncachedParse(const apit::Address& target)
+    {
+        auto scheme = utils::uri::scheme(target.value);
+        using namespace std::literals;
+        if("local"sv != scheme &&
+           "tcp4"sv  != scheme &&
+           "tcp6"sv  != scheme &&
+           "tcp"sv   != scheme)
+        {
+            throw api::BadAddress(target.value);
+        }
+
+        utils::URI<> uri;
+        if(!utils::uri::parse(target.value, uri))
+            throw api::BadAddress(target.value);
+
+        return std::visit([&]<class Alt>(const Alt& alt) -> std::string
+                          {
+                              if constexpr(std::is_same_v<utils::uri::TCP<>, Alt> ||
+                                           std::is_same_v<utils::uri::TCP4<>, Alt> ||
+                                           std::is_same_v<utils::uri::TCP6<>, Alt> ||
+                                           std::is_same_v<utils::uri::Local<>, Alt>)
+                                  return utils::uri::hostPort(alt);
+                              else
+                                  throw api::BadAddress(target.value);
+                          }, uri);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <class F>
+    real64 nsPerOp(std::size_t amount, F&& f)
+    {
+        Clock::time_point start = Clock::now();
+        for(std::size_t i{}; i<amount; ++i)
+        {
+            f(i);
+        }
+        return std::chrono::duration<real64, std::nano>(Clock::now() - start).count() / static_cast<real64>(amount);
+    }
+}
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(module_ppn_transport_net, benchParseAddress)
+{
+    constexpr std::size_t amount = 1'000'000;
+
+    const std::vector<apit::Address> addresses
+    {
+        apit::Address{"tcp4://127.0.0.1:4321"},
+        apit::Address{"tcp6://[::1]:4321"},
+        apit::Address{"tcp://some.host.example:4321"},
+        apit::Address{"local://some-socket"},
+    };
+
+    std::size_t volatile sink{};
+
+    real64 before = nsPerOp(amount, [&](std::size_t i)
+    {
+        sink = sink + uncachedParse(addresses[i % addresses.size()]).size();
+    });
+
+    //первый вызов на каждый адрес - промах кеша, полный разбор
+    for(const apit::Address& address : addresses)
+    {
+        EXPECT_EQ(parseAddress(address)->_hostPort, uncachedParse(address));
+    }
+
+    real64 after = nsPerOp(amount, [&](std::size_t i)
+    {
+        sink = sink + parseAddress(addresses[i % addresses.size()])->_hostPort.size();
+    });
+
+    std::cout << "address parse per connect: uncached " << before << " ns, interned " << after << " ns" << std::endl;
+
+    EXPECT_EQ(Scheme::tcp4, knownScheme("tcp4"));
+    EXPECT_FALSE(knownScheme("http"));
+    EXPECT_THROW(parseAddress(apit::Address{"http://host:1"}), api::BadAddress);
+}
@@ -0,0 +1,122 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "loopback.hpp"
+
+using namespace loopback;
+
+namespace
+{
+    constexpr std::size_t pingSize = 64;
+    constexpr std::size_t pings = 200;
+    constexpr std::size_t bulkChunk = 64*1024;
+    constexpr std::size_t bulkBytes = 16*1024*1024;
+
+    struct Latency
+    {
+        real64 _p50;
+        real64 _p99;
+        real64 _max;
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // small pings over one connection while, optionally, a bulk flow saturates another one of the same connector
+    Latency run(const api::Shaping& aggregate, const api::Shaping& channel, bool withBulk)
+    {
+        host::Manager* manager = host::testManager();
+        sbs::Owner owner;
+
+        api::Acceptor<> acceptor = manager->createService<api::Acceptor<>>().value();
+        std::vector<apit::Channel<>> accepted;
+        apit::Address address = listen(acceptor, apit::Address{"tcp4://127.0.0.1:0"}, owner, accepted);
+
+        api::Connector<> connector = manager->createService<api::Connector<>>().value();
+        connector->setShaping(api::Shaping{aggregate}, api::Shaping{channel}).value();
+
+        apit::Channel<> bulk = connector->connect(apit::Address{address}).value();
+        EXPECT_TRUE(waitUntil([&]{return accepted.size() == 1;}));
+        apit::Channel<> small = connector->connect(apit::Address{address}).value();
+        EXPECT_TRUE(waitUntil([&]{return accepted.size() == 2;}));
+
+        std::size_t bulkReceived{};
+        accepted[0]->input() += owner * [&](auto&& data)
+        {
+            bulkReceived += data.size();
+        };
+        accepted[0]->unlockInput();
+
+        std::deque<Clock::time_point> sent;
+        std::size_t smallReceived{};
+        std::vector<real64> latencies;
+        accepted[1]->input() += owner * [&](auto&& data)
+        {
+            Clock::time_point now = Clock::now();
+            smallReceived += data.size();
+            while(smallReceived >= pingSize && !sent.empty())
+            {
+                smallReceived -= pingSize;
+                latencies.push_back(std::chrono::duration<real64, std::micro>(now - sent.front()).count());
+                sent.pop_front();
+            }
+        };
+        accepted[1]->unlockInput();
+
+        if(withBulk)
+        {
+            for(std::size_t i{}; i<bulkBytes; i += bulkChunk)
+            {
+                bulk->output(makeBytes(bulkChunk));
+            }
+        }
+
+        for(std::size_t i{}; i<pings; ++i)
+        {
+            sent.push_back(Clock::now());
+            small->output(makeBytes(pingSize));
+            sleep(std::chrono::milliseconds{1});
+        }
+
+        EXPECT_TRUE(waitUntil([&]{return latencies.size() == pings;}));
+        if(withBulk)
+        {
+            EXPECT_TRUE(waitUntil([&]{return bulkReceived >= bulkBytes;}, std::chrono::seconds{30}));
+        }
+
+        owner.flush();
+        bulk->close();
+        small->close();
+        acceptor->stop();
+
+        return Latency{percentile(latencies, 0.5), percentile(latencies, 0.99), percentile(latencies, 1.0)};
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void report(const char* title, const Latency& l)
+    {
+        std::cout << title << ": p50 " << l._p50 << "us, p99 " << l._p99 << "us, max " << l._max << "us" << std::endl;
+    }
+}
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(module_ppn_transport_net, benchShapingTailLatency)
+{
+    const api::Shaping unlimited{0, 0};
+    const api::Shaping agg200M{200*1000*1000, 256*1024};
+    const api::Shaping agg100M{100*1000*1000, 256*1024};
+    const api::Shaping ch100M{100*1000*1000, 256*1024};
+
+    Latency alone = run(agg200M, ch100M, false);
+    report("small flow alone", alone);
+
+    //bulk упирается в собственный bucket, общий свободен: small не должен ждать вовсе
+    Latency ownLimited = run(agg200M, ch100M, true);
+    report("small vs bulk limited by its channel bucket", ownLimited);
+
+    //bulk выбирает весь общий bucket: small получает свою очередь каждый раунд DRR
+    Latency aggregateLimited = run(agg100M, unlimited, true);
+    report("small vs bulk saturating the aggregate bucket", aggregateLimited);
+}
@@ -0,0 +1,89 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/test.hpp>
+#include "pch.hpp"
+#include "stats.hpp"
+
+using namespace dci;
+using namespace dci::module::ppn::transport::net;
+
+namespace
+{
+    template <class F>
+    real64 nsPerOp(std::size_t amount, F&& f)
+    {
+        stats::Clock::time_point start = stats::Clock::now();
+        for(std::size_t i{}; i<amount; ++i)
+        {
+            f(i);
+        }
+        return std::chrono::duration<real64, std::nano>(stats::Clock::now() - start).count() / static_cast<real64>(amount);
+    }
+}
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+//только стоимость счетчиков, которые добавлены в Channel::output и received(),
+//без IDL-вызовов и shaper-а (в режиме без ограничений там лишь две проверки)
+TEST(module_ppn_transport_net, benchStatsHotPath)
+{
+    constexpr std::size_t amount = 10'000'000;
+
+    std::shared_ptr<stats::Transport> transport = std::make_shared<stats::Transport>();
+    apit::Address address{"tcp4://127.0.0.1:1"};
+    stats::Channel channel{transport, address};
+
+    std::size_t volatile sink{};
+    real64 bare = nsPerOp(amount, [&](std::size_t i)
+    {
+        sink = sink + (i & 0xff);
+    });
+
+    real64 counted = nsPerOp(amount, [&](std::size_t i)
+    {
+        sink = sink + (i & 0xff);
+        channel.output(i & 0xff);
+        channel.send();
+        channel.input(i & 0xff);
+    });
+
+    std::cout << "stats counters: bare " << bare << " ns/op, with counters " << counted << " ns/op, overhead " << (counted - bare) << " ns/op" << std::endl;
+
+    api::Stats s = transport->snapshot();
+    EXPECT_EQ(s.chunksOut, amount);
+    EXPECT_EQ(s.chunksIn, amount);
+    EXPECT_EQ(s.sendCalls, amount);
+    EXPECT_EQ(s.channels.size(), 1u);
+    EXPECT_EQ(s.inputLocked.count, 0u);
+    EXPECT_TRUE(s.channels.front().inputLocked.buckets.empty());
+}
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+TEST(module_ppn_transport_net, statsHistogram)
+{
+    stats::Histogram h;
+    for(uint64 v : {0u, 1u, 3u, 4u, 5u, 7u, 8u, 1000u})
+    {
+        h.add(v);
+    }
+
+    api::Histogram s = h.snapshot();
+    EXPECT_EQ(s.count, 8u);
+    EXPECT_EQ(s.sum, 1028u);
+    EXPECT_EQ(s.min, 0u);
+    EXPECT_EQ(s.max, 1000u);
+
+    //0..3 точно, 4..7 по одному, 8 начинает следующую степень двойки
+    ASSERT_GE(s.buckets.size(), 9u);
+    EXPECT_EQ(s.buckets[0], 1u);
+    EXPECT_EQ(s.buckets[1], 1u);
+    EXPECT_EQ(s.buckets[3], 1u);
+    EXPECT_EQ(s.buckets[4], 1u);
+    EXPECT_EQ(s.buckets[5], 1u);
+    EXPECT_EQ(s.buckets[7], 1u);
+    EXPECT_EQ(s.buckets[8], 1u);
+}
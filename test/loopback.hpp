@@ -0,0 +1,90 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <dci/test.hpp>
+#include "pch.hpp"
+
+namespace loopback
+{
+    using namespace dci;
+    using namespace dci::module::ppn::transport::net;
+
+    using Clock = std::chrono::steady_clock;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void sleep(std::chrono::milliseconds ms)
+    {
+        poll::WaitableTimer timer{ms};
+        timer.start();
+        cmt::waitAny(timer.waitable());
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <class Pred>
+    bool waitUntil(Pred&& pred, std::chrono::milliseconds limit = std::chrono::seconds{10})
+    {
+        Clock::time_point deadline = Clock::now() + limit;
+        while(!pred())
+        {
+            if(Clock::now() > deadline)
+            {
+                return false;
+            }
+            sleep(std::chrono::milliseconds{1});
+        }
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline Bytes makeBytes(std::size_t size)
+    {
+        std::string buf(size, '\x5a');
+
+        Bytes res;
+        res.end().write(buf.data(), buf.size());
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // started acceptor, all accepted channels are collected into 'accepted'
+    inline apit::Address listen(api::Acceptor<>& acceptor, const apit::Address& bindAddress, sbs::Owner& owner, std::vector<apit::Channel<>>& accepted)
+    {
+        std::shared_ptr<apit::Address> boundAddress = std::make_shared<apit::Address>();
+
+        acceptor->bind(apit::Address{bindAddress}).value();
+
+        acceptor->accepted() += owner * [&accepted](auto&& channel)
+        {
+            accepted.emplace_back(std::forward<decltype(channel)>(channel));
+        };
+
+        acceptor->started() += owner * [boundAddress](auto&&, auto&& bound)
+        {
+            *boundAddress = bound;
+        };
+
+        acceptor->start();
+        EXPECT_TRUE(waitUntil([&]{return !boundAddress->value.empty();}));
+
+        return *boundAddress;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline real64 percentile(std::vector<real64> values, real64 p)
+    {
+        if(values.empty())
+        {
+            return 0;
+        }
+
+        std::sort(values.begin(), values.end());
+        std::size_t idx = static_cast<std::size_t>(p * static_cast<real64>(values.size() - 1));
+        return values[idx];
+    }
+}